@@ -0,0 +1,234 @@
+// --------
+// includes
+// --------
+
+#include <algorithm> // max, sort
+#include <cstddef>   // size_t
+#include <cstdlib>   // abs, rand, srand
+#include <ctime>     // clock_gettime, timespec
+#include <iostream>  // cout, endl, ios_base
+#include <memory>    // allocator
+#include <new>       // bad_alloc
+#include <vector>    // vector
+
+#define private public	//defined so view() and a[] are reachable for fragmentation
+
+#include "Allocator.h"
+
+// ---
+// now
+// ---
+
+// nanoseconds from a monotonic clock, may need -lrt on older glibc
+
+long long now () {
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000LL + t.tv_nsec;}
+
+// -------------
+// fragmentation
+// -------------
+
+// 1 - largest free block / total free bytes, 0 for allocators without an array to walk
+
+template <typename A>
+double fragmentation (A&) {
+    return 0;}
+
+template <typename T, int N>
+double fragmentation (Allocator<T, N>& x) {
+    int i       = 0;
+    int total   = 0;
+    int largest = 0;
+    while (i < N) {
+        const int s = x.view(x.a[i]);
+        if (s > 0) {
+            total  += s;
+            largest = std::max(largest, s);}
+        i += std::abs(s) + 8;}
+    return (total == 0) ? 0 : 1 - double(largest) / total;}
+
+// --------------
+// BenchAllocator
+// --------------
+
+template <typename A>
+struct BenchAllocator {
+    // --------
+    // typedefs
+    // --------
+
+    typedef typename A::pointer pointer;
+
+    // ------
+    // rounds
+    // ------
+
+    static const int rounds = 10000;
+
+    // ----
+    // data
+    // ----
+
+    const char*            name;
+    A                      x;
+    std::vector<long long> lat;   // nanoseconds per allocate/deallocate call
+    double                 peak;  // peak fragmentation seen after any call
+
+    BenchAllocator (const char* n) :
+            name (n),
+            peak (0)
+        {}
+
+    // --------
+    // allocate
+    // --------
+
+    pointer allocate (std::size_t s) {
+        const long long b = now();
+        try {
+            const pointer p = x.allocate(s);
+            lat.push_back(now() - b);
+            peak = std::max(peak, fragmentation(x));
+            return p;}
+        catch (std::bad_alloc&) {
+            lat.push_back(now() - b);
+            throw;}}
+
+    // ----------
+    // deallocate
+    // ----------
+
+    void deallocate (pointer p, std::size_t s) {
+        const long long b = now();
+        x.deallocate(p, s);
+        lat.push_back(now() - b);
+        peak = std::max(peak, fragmentation(x));}
+
+    // ---------
+    // workloads
+    // ---------
+
+    void lifo () {
+        pointer p[3];
+        for (int r = 0; r != rounds; ++r) {
+            for (int i = 0; i != 3; ++i)
+                p[i] = allocate(1);
+            for (int i = 3; i != 0; --i)
+                deallocate(p[i - 1], 1);}}
+
+    void fifo () {
+        pointer p[3];
+        for (int r = 0; r != rounds; ++r) {
+            for (int i = 0; i != 3; ++i)
+                p[i] = allocate(1);
+            for (int i = 0; i != 3; ++i)
+                deallocate(p[i], 1);}}
+
+    void churn () {
+        // like test_chaos: keep three blocks live and replace a random one
+        pointer p[3];
+        srand(1);
+        for (int i = 0; i != 3; ++i)
+            p[i] = allocate(1);
+        for (int r = 0; r != rounds; ++r) {
+            const int i = rand() % 3;
+            deallocate(p[i], 1);
+            p[i] = allocate(1);}
+        for (int i = 0; i != 3; ++i)
+            deallocate(p[i], 1);}
+
+    void mixed () {
+        // sizes 1, 2, 1 freed in a random order
+        pointer     p[3];
+        std::size_t s[3] = {1, 2, 1};
+        srand(1);
+        for (int r = 0; r != rounds; ++r) {
+            for (int i = 0; i != 3; ++i)
+                p[i] = allocate(s[i]);
+            const int f = rand() % 3;
+            for (int i = 0; i != 3; ++i)
+                deallocate(p[(f + i) % 3], s[(f + i) % 3]);}}
+
+    void fill () {
+        // allocate until bad_alloc, capped for allocators that never run out
+        std::vector<pointer> p;
+        for (int r = 0; r != rounds; ++r) {
+            try {
+                while (p.size() != 16)
+                    p.push_back(allocate(1));}
+            catch (std::bad_alloc&) {}
+            while (!p.empty()) {
+                deallocate(p.back(), 1);
+                p.pop_back();}}}
+
+    // ------
+    // report
+    // ------
+
+    // one CSV line: allocator,workload,ops,ops_per_sec,p50_ns,p99_ns,p999_ns,peak_fragmentation
+
+    void report (const char* workload) {
+        using namespace std;
+        sort(lat.begin(), lat.end());
+        long long total = 0;
+        for (size_t i = 0; i != lat.size(); ++i)
+            total += lat[i];
+        cout << "\"" << name << "\"," << workload << "," << lat.size() << ","
+             << ((total == 0) ? 0 : lat.size() * 1e9 / total) << ","
+             << percentile(0.5) << "," << percentile(0.99) << "," << percentile(0.999) << ","
+             << peak << endl;
+        lat.clear();
+        peak = 0;}
+
+    long long percentile (double q) const {
+        if (lat.empty())
+            return 0;
+        return lat[std::min(lat.size() - 1, static_cast<std::size_t>(lat.size() * q))];}};
+
+// -----
+// bench
+// -----
+
+template <typename A>
+void bench (const char* name) {
+    BenchAllocator<A> b(name);
+    b.lifo();
+    b.report("lifo");
+    b.fifo();
+    b.report("fifo");
+    b.churn();
+    b.report("churn");
+    b.mixed();
+    b.report("mixed");
+    b.fill();
+    b.report("fill");}
+
+// ----
+// main
+// ----
+
+int main () {
+    using namespace std;
+    ios_base::sync_with_stdio(false);    // turn off synchronization with C I/O
+    cout << "allocator,workload,ops,ops_per_sec,p50_ns,p99_ns,p999_ns,peak_fragmentation" << endl;
+
+    //same pairs as TestAllocator.c++, always comparing against the std allocator
+
+    bench< std::allocator<int> >("std::allocator<int>");
+	bench< Allocator<int, 100> >("Allocator<int, 100>");
+
+    bench< std::allocator<double> >("std::allocator<double>");
+	bench< Allocator<double, 100> >("Allocator<double, 100>");
+
+    bench< std::allocator<float> >("std::allocator<float>");
+	bench< Allocator<float, 100> >("Allocator<float, 100>");
+
+    bench< std::allocator<char> >("std::allocator<char>");
+	bench< Allocator<char, 100> >("Allocator<char, 100>");
+
+    bench< std::allocator<bool> >("std::allocator<bool>");
+	bench< Allocator<bool, 100> >("Allocator<bool, 100>");
+
+    return 0;}
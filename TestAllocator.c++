@@ -147,6 +147,73 @@ struct CustomAllocator : CppUnit::TestFixture {
 		//is it valid? - well, it shouldn't be
 		CPPUNIT_ASSERT(!x.valid());
 	}
+	void test_valid6()
+	{
+		//test with a broken footer in the middle of the array
+
+		Allocator<int, 100> x;
+
+		//alloc a1-a3
+		x.allocate(3);
+		x.allocate(3);
+		x.allocate(3);
+
+		CPPUNIT_ASSERT(x.valid());
+
+		//break the footer of a2
+		x.view(x.a[36]) = -8;
+
+		//is it valid? - well, it shouldn't be
+		CPPUNIT_ASSERT(!x.valid());
+	}
+	void test_valid7()
+	{
+		//test with a header and footer that disagree on whether the block is free
+
+		Allocator<int, 100> x;
+
+		//the footer at a[96] still says 92 bytes free
+		x.view(x.a[0]) = -92;
+
+		//is it valid? - well, it shouldn't be
+		CPPUNIT_ASSERT(!x.valid());
+	}
+	void test_valid8()
+	{
+		//test that every split and coalesce leaves the array valid
+
+		Allocator<int, 200> x;
+		int* a[5];
+
+		//alloc a1-a5, each one splitting the free block
+		for(int i=0;i<5;++i)
+		{
+			a[i] = x.allocate(4);
+			CPPUNIT_ASSERT(x.valid());
+		}
+
+		//dealloc a2 - no merge
+		x.deallocate(a[1]);
+		CPPUNIT_ASSERT(x.valid());
+
+		//dealloc a3 - merges with the block before it
+		x.deallocate(a[2]);
+		CPPUNIT_ASSERT(x.valid());
+
+		//dealloc a1 - merges with the block after it
+		x.deallocate(a[0]);
+		CPPUNIT_ASSERT(x.valid());
+
+		//dealloc a5 - merges with the free space after it
+		x.deallocate(a[4]);
+		CPPUNIT_ASSERT(x.valid());
+
+		//dealloc a4 - merges with the blocks on both sides
+		x.deallocate(a[3]);
+		CPPUNIT_ASSERT(x.valid());
+
+		CPPUNIT_ASSERT(x.view(x.a[0]) == 192);
+	}
 
 	void test_allocate1()
 	{
@@ -232,6 +299,9 @@ struct CustomAllocator : CppUnit::TestFixture {
 		p2 = x.allocate(7);
 
 		CPPUNIT_ASSERT(p1 == p2);
+
+		//the rest of a2 was split off as a free block
+		CPPUNIT_ASSERT(x.view(x.a[56]) == 8);
 	}
 	void test_allocate5()
 	{
@@ -265,6 +335,99 @@ struct CustomAllocator : CppUnit::TestFixture {
 
 		CPPUNIT_ASSERT(*(p1-1)==-40 && *(p2-1)==-44);
 	}
+	void test_allocate7()
+	{
+		//test that the first hole that fits is used, not the best fitting one
+
+		Allocator<int, 200> x;
+		int *p1, *p2, *p3;
+
+		//alloc a1 - the large hole
+		p1 = x.allocate(10);
+
+		//alloc a2
+		x.allocate(2);
+
+		//alloc a3 - the perfectly fitting hole
+		p2 = x.allocate(4);
+
+		//alloc a4
+		x.allocate(2);
+
+		//dealloc a1 and a3
+		x.deallocate(p1);
+		x.deallocate(p2);
+
+		//alloc a5 - a3 would be the best fit, but a1 comes first
+		p3 = x.allocate(4);
+
+		CPPUNIT_ASSERT(p3 == p1);
+		CPPUNIT_ASSERT(x.valid());
+	}
+	void test_allocate8()
+	{
+		//test that a hole too small for the request is skipped
+
+		Allocator<int, 200> x;
+		int *p1, *p2, *p3;
+
+		//alloc a1 - the small hole
+		p1 = x.allocate(2);
+
+		//alloc a2
+		x.allocate(1);
+
+		//alloc a3 - the hole that fits
+		p2 = x.allocate(6);
+
+		//alloc a4
+		x.allocate(1);
+
+		//dealloc a1 and a3
+		x.deallocate(p1);
+		x.deallocate(p2);
+
+		//alloc a5 - doesn't fit in a1, so it goes in a3 rather than the tail
+		p3 = x.allocate(5);
+
+		CPPUNIT_ASSERT(p3 == p2);
+		CPPUNIT_ASSERT(*(p3-1) == -24);
+		CPPUNIT_ASSERT(x.valid());
+	}
+	void test_allocate9()
+	{
+		//test when there is enough free space in total, but no single block is big enough
+
+		Allocator<int, 100> x;
+		int *p1, *p2;
+
+		//alloc a1-a4 - leaving a 3 int block at the end
+		p1 = x.allocate(3);
+		x.allocate(3);
+		p2 = x.allocate(3);
+		x.allocate(3);
+
+		//dealloc a1 and a3 - three 3 int holes, 36 bytes free
+		x.deallocate(p1);
+		x.deallocate(p2);
+
+		//alloc a5 - fits in the free space, but not in any one hole
+		try
+		{
+			x.allocate(4);
+			CPPUNIT_ASSERT(false);
+		}
+		catch(std::bad_alloc&)
+		{
+			CPPUNIT_ASSERT(true);
+		}
+
+		//the failed alloc left the array untouched
+		CPPUNIT_ASSERT(x.view(x.a[0]) == 12);
+		CPPUNIT_ASSERT(x.view(x.a[40]) == 12);
+		CPPUNIT_ASSERT(x.view(x.a[80]) == 12);
+		CPPUNIT_ASSERT(x.valid());
+	}
 
 	void test_dealloc1()
 	{
@@ -321,6 +484,172 @@ struct CustomAllocator : CppUnit::TestFixture {
 
 		CPPUNIT_ASSERT(*(reinterpret_cast<int*>(p1)-1) == 192);
 	}
+	void test_dealloc4()
+	{
+		//test that the standard deallocate(p, n) coalesces just like deallocate(p)
+
+		Allocator<double, 104> x;
+		double *p1, *p2;
+
+		//alloc a1
+		p1 = x.allocate(5);
+
+		//alloc a2 - taking up the rest of the allocator
+		p2 = x.allocate(6);
+
+		//dealloc a1 and a2, passing the counts
+		x.deallocate(p1, 5);
+		x.deallocate(p2, 6);
+
+		CPPUNIT_ASSERT(*(reinterpret_cast<int*>(p1)-1) == 96);
+		CPPUNIT_ASSERT(x.valid());
+	}
+	void test_dealloc5()
+	{
+		//test that the whole array is usable again once every block is freed
+
+		Allocator<char, 100> x;
+		char* a[11];
+
+		//alloc a1-a11 - fill the array
+		for(int i=0;i<10;++i)
+			a[i] = x.allocate(1);
+		a[10] = x.allocate(2);
+
+		//dealloc a1-a11, out of order
+		for(int i=0;i<11;i+=2)
+			x.deallocate(a[i]);
+		for(int i=1;i<11;i+=2)
+			x.deallocate(a[i]);
+
+		CPPUNIT_ASSERT(x.view(x.a[0]) == 92);
+
+		//alloc a12 - take all of the space again
+		CPPUNIT_ASSERT(x.allocate(92) == &x.a[4]);
+		CPPUNIT_ASSERT(x.valid());
+	}
+	void test_dealloc6()
+	{
+		//test that blocks freed after a live block merge right behind it - the space an in-place grow would take
+
+		Allocator<int, 200> x;
+		int *p1, *p2, *p3;
+
+		//alloc a1 - stays live
+		p1 = x.allocate(4);
+		x.construct(p1, 7);
+
+		//alloc a2 and a3 - its neighbours
+		p2 = x.allocate(4);
+		p3 = x.allocate(4);
+
+		//alloc a4 - keeps a3 from merging with the rest of the free space
+		x.allocate(4);
+
+		//dealloc a3, then a2 - merged into one 40 byte block at a2's address
+		x.deallocate(p3);
+		x.deallocate(p2);
+
+		CPPUNIT_ASSERT(*p1 == 7);
+		CPPUNIT_ASSERT(x.view(x.a[0]) == -16 && x.view(x.a[20]) == -16);
+		CPPUNIT_ASSERT(x.view(x.a[24]) == 40 && x.view(x.a[68]) == 40);
+		CPPUNIT_ASSERT(x.view(x.a[72]) == -16);
+		CPPUNIT_ASSERT(x.valid());
+	}
+	void test_lifo()
+	{
+		//test freeing blocks in the reverse of the order they were allocated
+
+		Allocator<int, 100> x;
+		int* a[3];
+
+		//alloc a1-a3
+		for(int i=0;i<3;++i)
+			a[i] = x.allocate(3);
+
+		//dealloc a3-a1 - each one merges with the free space after it
+		for(int i=3;i!=0;--i)
+		{
+			x.deallocate(a[i-1]);
+			CPPUNIT_ASSERT(x.view(x.a[(i-1)*20]) == 92-(i-1)*20);
+		}
+
+		CPPUNIT_ASSERT(x.view(x.a[0]) == 92);
+		CPPUNIT_ASSERT(x.valid());
+	}
+	void test_fifo()
+	{
+		//test freeing blocks in the order they were allocated
+
+		Allocator<int, 100> x;
+		int* a[3];
+
+		//alloc a1-a3
+		for(int i=0;i<3;++i)
+			a[i] = x.allocate(3);
+
+		//dealloc a1-a3 - each one merges with the free block before it
+		for(int i=0;i<3;++i)
+			x.deallocate(a[i]);
+
+		CPPUNIT_ASSERT(x.view(x.a[0]) == 92);
+		CPPUNIT_ASSERT(x.valid());
+	}
+	void test_instance1()
+	{
+		//test that two allocators don't share an array
+
+		Allocator<int, 100> x;
+		Allocator<int, 100> y;
+		int *p1, *p2;
+
+		//alloc a1 in x - take all of the space
+		p1 = x.allocate(23);
+
+		//alloc a2 in y - should still have all of its space
+		p2 = y.allocate(23);
+
+		CPPUNIT_ASSERT(p1 != p2);
+		CPPUNIT_ASSERT(x.view(x.a[0]) == -92);
+		CPPUNIT_ASSERT(y.view(y.a[0]) == -92);
+
+		//dealloc a1 - y is left alone
+		x.deallocate(p1);
+
+		CPPUNIT_ASSERT(x.view(x.a[0]) == 92);
+		CPPUNIT_ASSERT(y.view(y.a[0]) == -92);
+		CPPUNIT_ASSERT(x.valid() && y.valid());
+	}
+	void test_replay()
+	{
+		//test that replaying a recorded trace gives the recorded layout
+
+		Allocator<int, 400> x;
+		int* p[10];
+
+		//the trace - size and block id of each alloc, blocks 1-10 are freed before reuse
+		const int n[20]   = {3, 1, 4, 1, 5, 2, 2, 3, 5, 4, 2, 6, 1, 3, 4, 2, 5, 1, 3, 2};
+		const int id[20]  = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 3, 1, 7, 0, 5, 2, 9, 4, 8, 6};
+
+		//the recorded offset of each alloc into the array
+		const int off[20] = {4, 24, 36, 60, 72, 100, 116, 132, 152, 180,
+		                     204, 220, 24, 4, 252, 36, 276, 52, 64, 84};
+
+		//replay the trace by block id
+		for(int i=0;i<20;++i)
+		{
+			if(i>=10)
+				x.deallocate(p[id[i]]);
+			p[id[i]] = x.allocate(n[i]);
+			CPPUNIT_ASSERT(reinterpret_cast<char*>(p[id[i]]) - x.a == off[i]);
+		}
+
+		//the recorded final state
+		CPPUNIT_ASSERT(x.view(x.a[0]) == -12);
+		CPPUNIT_ASSERT(x.view(x.a[80]) == -8);
+		CPPUNIT_ASSERT(x.view(x.a[96]) == 96);
+		CPPUNIT_ASSERT(x.valid());
+	}
 	template <typename T>
 	void test_chaos()
 	{
@@ -331,7 +660,7 @@ struct CustomAllocator : CppUnit::TestFixture {
 			T *p[100];
 			int r;
 
-			srand(time(NULL));
+			srand(num+1);
 
 			try
 			{
@@ -345,7 +674,7 @@ struct CustomAllocator : CppUnit::TestFixture {
 				for(int i=0;i<1000;++i)
 				{
 					r = rand()%100;
-					x.destroy(p[i*2]);
+					x.destroy(p[r]);
 					x.deallocate(p[r]);
 					p[r] = x.allocate((rand()%10)+1);
 				}
@@ -387,15 +716,28 @@ struct CustomAllocator : CppUnit::TestFixture {
 	CPPUNIT_TEST(test_valid3);
 	CPPUNIT_TEST(test_valid4);
 	CPPUNIT_TEST(test_valid5);
+	CPPUNIT_TEST(test_valid6);
+	CPPUNIT_TEST(test_valid7);
+	CPPUNIT_TEST(test_valid8);
 	CPPUNIT_TEST(test_allocate1);
 	CPPUNIT_TEST(test_allocate2);
 	CPPUNIT_TEST(test_allocate3);
 	CPPUNIT_TEST(test_allocate4);
 	CPPUNIT_TEST(test_allocate5);
 	CPPUNIT_TEST(test_allocate6);
+	CPPUNIT_TEST(test_allocate7);
+	CPPUNIT_TEST(test_allocate8);
+	CPPUNIT_TEST(test_allocate9);
 	CPPUNIT_TEST(test_dealloc1);
 	CPPUNIT_TEST(test_dealloc2);
 	CPPUNIT_TEST(test_dealloc3);
+	CPPUNIT_TEST(test_dealloc4);
+	CPPUNIT_TEST(test_dealloc5);
+	CPPUNIT_TEST(test_dealloc6);
+	CPPUNIT_TEST(test_lifo);
+	CPPUNIT_TEST(test_fifo);
+	CPPUNIT_TEST(test_instance1);
+	CPPUNIT_TEST(test_replay);
 	CPPUNIT_TEST(test_chaos<int>);
 	CPPUNIT_TEST(test_chaos<float>);
 	CPPUNIT_TEST(test_chaos<double>);